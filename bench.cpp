@@ -32,6 +32,43 @@
     surface (serialize_*_compile_time), to answer whether moving min/max/bits into template
     arguments buys anything the optimizer wasn't already doing.
 
+    And measures FanOutWriter against running the whole Serialize per client, for a world state
+    section sent to 1, 64 and 512 clients.
+
+    And measures PacketAssembler against sorting every entity and measuring each one before writing
+    it, filling a 1200 byte packet from 200 and 2000 prioritized entities.
+
+    And measures MessagePacker against filling packets in queue order: packets used, how full they
+    are, and messages per second through measure, pack and write.
+
+    And measures reading one field from each of many recorded snapshots: decoding each record up
+    to the field, skipping the substreams before it, and seeking straight to it with a field index.
+
+    And measures 2000 rigid bodies serialized object by object against the same fields serialized a
+    column at a time, with each integer column raw, run length or delta coded.
+
+    And measures BatchWriter writing 1024 client snapshots of about 4KB each, on one thread and on
+    up to every core.
+
+    And measures BatchReader reading 64 packet batches, headers on one thread and bodies routed to
+    threads by connection, from memory and (on Linux) through UDP loopback with recvmmsg.
+
+    And measures handing packets from a writer thread to a reader thread through PacketRing, against
+    a mutex guarded queue that copies them in and out.
+
+    And measures a CRC32C checksum over a log of packets and on every packet, computed after writing
+    against folded in as each word is stored, and verified on read.
+
+    And measures reading messages with a variable number of items into an array of the largest
+    size, into exactly the items allocated from the heap, and into the same from an arena.
+
+    And measures logging a million packets to a file through FileWriteStream's 64KB double buffer,
+    with writes in line and from a background thread, against writing them all into one buffer in
+    memory and writing that out at the end.
+
+    And measures reading random records out of a memory mapped replay file of 20000 packets, through
+    its index, against finding each one by decoding the records before it.
+
     Each benchmark runs several trials and reports the best, to shave off scheduler noise.
     Only release build numbers are meaningful.
 */
@@ -41,6 +78,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <chrono>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+
+#if defined( __linux__ )
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif // #if defined( __linux__ )
 
 static volatile uint64_t g_sink = 0;            // defeats dead code elimination of computed values
 
@@ -293,271 +340,1997 @@ void bench_stream()
 
 // ------------------------------------------------------------------------------------------
 
-// Matched pairs: the same packet serialized through the runtime macros and through the compile
-// time parameter surface. Same data, same serially dependent LCG variation pattern, same escape
-// barriers, same trial structure, so any difference is the forms themselves, not the harness.
-// Each shape derives its two packet forms from one fields struct, so a single vary function
-// drives both sides of a pair with identical values.
+// Fan-out: the same world state section sent to N clients, each packet differing only in a
+// per-client header. "per client" runs the whole Serialize for every client; "fan-out" runs the
+// world state's Serialize once per round through FanOutWriter and splices its bits in behind each
+// header. The world state has no aligns, so the splice lands at any header length.
 
-template <typename Fields, typename Packet> void bench_packet_shape( const char * label, uint64_t (*vary)( Fields &, uint64_t ) )
+const int FanOutNumEntities = 64;
+const int FanOutPacketsPerTrial = 262144;
+
+struct BenchFanOutWorld
 {
-    uint8_t buffer[256];
+    int32_t x[FanOutNumEntities], y[FanOutNumEntities], z[FanOutNumEntities];
+    uint32_t yaw[FanOutNumEntities];
+    bool moving[FanOutNumEntities];
+
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        for ( int i = 0; i < FanOutNumEntities; i++ )
+        {
+            serialize_int( stream, x[i], -100000, +100000 );
+            serialize_int( stream, y[i], -100000, +100000 );
+            serialize_int( stream, z[i], -1000, +1000 );
+            serialize_bits( stream, yaw[i], 10 );
+            serialize_bool( stream, moving[i] );
+        }
+        return true;
+    }
+};
+
+struct BenchFanOutHeader
+{
+    uint32_t sequence, ack, ack_bits;
+    int32_t client_index;
+
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        serialize_bits( stream, sequence, 16 );
+        serialize_bits( stream, ack, 16 );
+        serialize_bits( stream, ack_bits, 32 );
+        serialize_int( stream, client_index, 0, 511 );
+        return true;
+    }
+};
+
+struct BenchFanOutPacket
+{
+    BenchFanOutHeader * header;
+    BenchFanOutWorld * world;
+
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        if ( !header->Serialize( stream ) )
+            return false;
+        return world->Serialize( stream );
+    }
+};
+
+void bench_fan_out( int num_clients )
+{
+    BenchFanOutWorld world;
+    uint64_t rng = 1;
+    for ( int i = 0; i < FanOutNumEntities; i++ )
+    {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        world.x[i] = int32_t( ( rng >> 20 ) % 200001 ) - 100000;
+        world.y[i] = int32_t( ( rng >> 30 ) % 200001 ) - 100000;
+        world.z[i] = int32_t( ( rng >> 40 ) % 2001 ) - 1000;
+        world.yaw[i] = uint32_t( rng >> 8 ) & 1023;
+        world.moving[i] = ( rng & 1 ) != 0;
+    }
+
+    BenchFanOutHeader header;
+    header.ack_bits = 0xFFFF00FF;
+
+    const int BufferSize = 1024;
+    uint8_t shared_buffer[BufferSize];
+    uint8_t buffer[BufferSize];
     memset( buffer, 0, sizeof( buffer ) );
 
-    Packet packet = Packet();
+    const int rounds = FanOutPacketsPerTrial / num_clients;
+    int64_t bytes_per_packet = 0;
 
-    // pre-write variant packets for the read benchmark, using the same LCG sequence as the write loop
-    uint8_t variant_buffers[NumVariants][256];
-    int bytes_per_packet = 0;
+    double best_per_client = 1e30;
+    double best_fan_out = 1e30;
+
+    for ( int trial = 0; trial < NumTrials; trial++ )
     {
-        uint64_t rng = 1;
-        for ( int k = 0; k < NumVariants; k++ )
+        double start = time_now();
+        for ( int round = 0; round < rounds; round++ )
         {
-            memset( variant_buffers[k], 0, sizeof( variant_buffers[k] ) );
-            rng = vary( packet, rng );
-            serialize::WriteStream stream( variant_buffers[k], (int) sizeof( variant_buffers[k] ) );
-            if ( !packet.Serialize( stream ) )
+            world.x[round & ( FanOutNumEntities - 1 )] = round & 0xFFFF;        // the world changes every round
+            for ( int client = 0; client < num_clients; client++ )
+            {
+                header.sequence = uint32_t( round ) & 0xFFFF;
+                header.ack = uint32_t( round + client ) & 0xFFFF;
+                header.client_index = client;
+                BenchFanOutPacket packet = { &header, &world };
+                serialize::WriteStream stream( buffer, BufferSize );
+                if ( !packet.Serialize( stream ) )
+                    exit( 1 );
+                stream.Flush();
+                bench_escape( buffer );
+                bytes_per_packet = stream.GetBytesProcessed();
+                g_sink = g_sink + (uint64_t) bytes_per_packet;
+            }
+        }
+        double time = time_now() - start;
+        if ( time < best_per_client )
+            best_per_client = time;
+
+        start = time_now();
+        for ( int round = 0; round < rounds; round++ )
+        {
+            world.x[round & ( FanOutNumEntities - 1 )] = round & 0xFFFF;
+            serialize::FanOutWriter fanout( shared_buffer, BufferSize );
+            if ( !fanout.SerializeShared( world ) )
                 exit( 1 );
-            stream.Flush();
-            bytes_per_packet = stream.GetBytesProcessed();
+            for ( int client = 0; client < num_clients; client++ )
+            {
+                header.sequence = uint32_t( round ) & 0xFFFF;
+                header.ack = uint32_t( round + client ) & 0xFFFF;
+                header.client_index = client;
+                serialize::WriteStream stream( buffer, BufferSize );
+                if ( !fanout.WriteClient( header, stream ) )
+                    exit( 1 );
+                bench_escape( buffer );
+                g_sink = g_sink + (uint64_t) stream.GetBytesProcessed();
+            }
         }
+        time = time_now() - start;
+        if ( time < best_fan_out )
+            best_fan_out = time;
     }
 
-    double best_write = 1e30;
-    double best_read = 1e30;
+    const double packets = double( rounds ) * num_clients / 1000000.0;
 
-    for ( int trial = 0; trial < NumTrials; trial++ )
+    printf( "fan-out %3d clients (%d byte packets)  per client: %6.2f M packets/s   fan-out: %6.2f M packets/s   (%.1fx)\n",
+        num_clients, (int) bytes_per_packet, packets / best_per_client, packets / best_fan_out, best_per_client / best_fan_out );
+}
+
+// ------------------------------------------------------------------------------------------
+
+// Priority packet assembly: filling a 1200 byte packet with the most important of N entities.
+// "sort + measure" is the usual loop: sort every entity by priority, measure each one with a
+// MeasureStream, and write it if it fits. "assembler" is PacketAssembler: a heap that only orders
+// the entities it reaches, and one write per entity, rolled back if it lands past the budget.
+// Both make the same choice: the sort is by the same priority and the same tie break.
+
+const int AssemblerBudget = 1200;
+const int AssemblerPacketsPerTrial = 4096;
+
+struct BenchAssemblerEntity
+{
+    int32_t id;
+    int32_t x, y, z;
+    uint32_t yaw;
+    bool has_velocity;
+    int32_t vx, vy, vz;
+
+    template <typename Stream> bool Serialize( Stream & stream )
     {
-        uint64_t rng = 1;
+        serialize_int( stream, id, 0, 4095 );
+        serialize_int( stream, x, -100000, +100000 );
+        serialize_int( stream, y, -100000, +100000 );
+        serialize_int( stream, z, -1000, +1000 );
+        serialize_bits( stream, yaw, 10 );
+        serialize_bool( stream, has_velocity );
+        if ( has_velocity )
+        {
+            serialize_int( stream, vx, -5000, +5000 );
+            serialize_int( stream, vy, -5000, +5000 );
+            serialize_int( stream, vz, -5000, +5000 );
+        }
+        return true;
+    }
+};
+
+static const float * bench_priorities = NULL;
+
+static bool bench_priority_greater( int a, int b )
+{
+    return bench_priorities[a] > bench_priorities[b] || ( bench_priorities[a] == bench_priorities[b] && a < b );
+}
+
+void bench_packet_assembler( int num_entities )
+{
+    BenchAssemblerEntity * entities = new BenchAssemblerEntity[num_entities];
+    float * priorities = new float[num_entities];
+    int * order = new int[num_entities];
+    uint64_t rng = 1;
+    for ( int i = 0; i < num_entities; i++ )
+    {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        entities[i].id = i;
+        entities[i].x = int32_t( ( rng >> 20 ) % 200001 ) - 100000;
+        entities[i].y = int32_t( ( rng >> 30 ) % 200001 ) - 100000;
+        entities[i].z = int32_t( ( rng >> 40 ) % 2001 ) - 1000;
+        entities[i].yaw = uint32_t( rng >> 8 ) & 1023;
+        entities[i].has_velocity = ( rng & 1 ) != 0;
+        entities[i].vx = int32_t( ( rng >> 12 ) % 10001 ) - 5000;
+        entities[i].vy = int32_t( ( rng >> 22 ) % 10001 ) - 5000;
+        entities[i].vz = int32_t( ( rng >> 32 ) % 10001 ) - 5000;
+        priorities[i] = float( ( rng >> 41 ) % 1000 );
+    }
+    bench_priorities = priorities;
+
+    const int BufferSize = AssemblerBudget + 64;
+    uint8_t buffer[BufferSize];
+    memset( buffer, 0, sizeof( buffer ) );
 
+    int sent_sort = 0;
+    int sent_assembler = 0;
+
+    double best_sort = 1e30;
+    double best_assembler = 1e30;
+
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
         double start = time_now();
-        for ( int i = 0; i < StreamNumPackets; i++ )
+        for ( int packet = 0; packet < AssemblerPacketsPerTrial; packet++ )
         {
-            rng = vary( packet, rng );
-            serialize::WriteStream stream( buffer, (int) sizeof( buffer ) );
-            if ( !packet.Serialize( stream ) )
-                exit( 1 );
+            priorities[packet % num_entities] += 1.0f;           // accumulators move between packets
+            for ( int i = 0; i < num_entities; i++ )
+                order[i] = i;
+            std::sort( order, order + num_entities, bench_priority_greater );
+            serialize::WriteStream stream( buffer, BufferSize );
+            int64_t bits = 0;
+            int failures = 0;
+            sent_sort = 0;
+            for ( int i = 0; i < num_entities && failures < 8 && bits + 2 <= AssemblerBudget * 8; i++ )
+            {
+                serialize::MeasureStream measure;
+                entities[order[i]].Serialize( measure );
+                if ( bits + 1 + measure.GetBitsProcessed() + 1 > AssemblerBudget * 8 )
+                {
+                    failures++;
+                    continue;
+                }
+                uint32_t follows = 1;
+                stream.SerializeBits( follows, 1 );
+                entities[order[i]].Serialize( stream );
+                bits += 1 + measure.GetBitsProcessed();
+                failures = 0;
+                sent_sort++;
+            }
+            uint32_t follows = 0;
+            stream.SerializeBits( follows, 1 );
             stream.Flush();
             bench_escape( buffer );
             g_sink = g_sink + (uint64_t) stream.GetBytesProcessed();
         }
         double time = time_now() - start;
-        if ( time < best_write )
-            best_write = time;
+        if ( time < best_sort )
+            best_sort = time;
 
         start = time_now();
-        for ( int i = 0; i < StreamNumPackets; i++ )
+        for ( int packet = 0; packet < AssemblerPacketsPerTrial; packet++ )
         {
-            serialize::ReadStream stream( variant_buffers[i & ( NumVariants - 1 )], bytes_per_packet );
-            Packet read_packet;
-            if ( !read_packet.Serialize( stream ) )
-                exit( 1 );
-            bench_escape( &read_packet );               // every decoded field is observed, so the full decode must happen
-            g_sink = g_sink + (uint64_t) *(const uint8_t*) &read_packet;
+            priorities[packet % num_entities] += 1.0f;
+            serialize::WriteStream stream( buffer, BufferSize );
+            serialize::PacketAssembler assembler( stream, AssemblerBudget );
+            sent_assembler = assembler.Assemble( entities, priorities, num_entities, order );
+            stream.Flush();
+            bench_escape( buffer );
+            g_sink = g_sink + (uint64_t) stream.GetBytesProcessed();
         }
         time = time_now() - start;
-        if ( time < best_read )
-            best_read = time;
+        if ( time < best_assembler )
+            best_assembler = time;
     }
 
-    const double packets = double( StreamNumPackets ) / 1000000.0;
+    const double packets = double( AssemblerPacketsPerTrial ) / 1000.0;
 
-    printf( "%s  write: %6.1f M packets/s   read: %6.1f M packets/s\n", label, packets / best_write, packets / best_read );
+    printf( "packet assembly %5d entities (%d + %d sent)  sort + measure: %7.1f K packets/s   assembler: %7.1f K packets/s   (%.1fx)\n",
+        num_entities, sent_sort, sent_assembler, packets / best_sort, packets / best_assembler, best_sort / best_assembler );
+
+    delete [] entities;
+    delete [] priorities;
+    delete [] order;
 }
 
-// pair 1: a realistic packet of ~10 bounded ints, runtime serialize_int vs serialize_int_compile_time
+// ------------------------------------------------------------------------------------------
 
-struct BenchIntFields
-{
-    int32_t f0, f1, f2, f3, f4, f5, f6, f7, f8, f9;
-};
+// Message packing: a queue of 64 messages of varied size, on 4 ordered channels, into 1200 byte
+// packets. "fifo" fills each packet in queue order and starts a new one when the next message
+// doesn't fit. "packer" is MessagePacker's first fit decreasing, keeping each channel in order, and
+// with no ordering at all. Fill is the share of the packets' bytes the messages take. All of them
+// measure each message once and write each packet once.
 
-inline uint64_t bench_vary_int_fields( BenchIntFields & f, uint64_t rng )
-{
-    rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
-    f.f0 = int32_t( ( rng >> 8 ) & 63 ) - 32;                       // within [-100,+100]
-    f.f1 = int32_t( uint32_t( rng >> 16 ) & 65535 );                // [0,65535]
-    f.f2 = int32_t( ( rng >> 24 ) & 0xFFFFF ) - 500000;             // within [-1000000,+1000000]
-    f.f3 = int32_t( uint32_t( rng >> 2 ) & 3 );                     // [0,3]
-    f.f4 = int32_t( ( rng >> 11 ) & 15 ) - 8;                       // within [-15,+15]
-    f.f5 = int32_t( uint32_t( rng >> 22 ) & 511 );                  // within [0,1000]
-    f.f6 = int32_t( ( rng >> 33 ) & 2047 ) - 1024;                  // within [-2048,+2047]
-    f.f7 = int32_t( uint32_t( rng >> 40 ) & 255 );                  // [0,255]
-    f.f8 = int32_t( ( rng >> 30 ) & 0xFFFFF ) - 500000;             // within [-600000,+600000]
-    f.f9 = int32_t( uint32_t( rng >> 57 ) & 63 );                   // within [0,100]
-    return rng;
-}
+const int PackerNumMessages = 64;
+const int PackerPacketBytes = 1200;
+const int PackerQueuesPerTrial = 8192;
 
-struct BenchIntPacketRuntime : public BenchIntFields
+struct BenchPackerMessage
 {
+    int32_t channel;
+    int32_t id;
+    int32_t num_values;
+    uint32_t values[180];
+
     template <typename Stream> bool Serialize( Stream & stream )
     {
-        serialize_int( stream, f0, -100, +100 );
-        serialize_int( stream, f1, 0, 65535 );
-        serialize_int( stream, f2, -1000000, +1000000 );
-        serialize_int( stream, f3, 0, 3 );
-        serialize_int( stream, f4, -15, +15 );
-        serialize_int( stream, f5, 0, 1000 );
-        serialize_int( stream, f6, -2048, +2047 );
-        serialize_int( stream, f7, 0, 255 );
-        serialize_int( stream, f8, -600000, +600000 );
-        serialize_int( stream, f9, 0, 100 );
+        serialize_int( stream, channel, 0, 3 );
+        serialize_int( stream, id, 0, 65535 );
+        serialize_int( stream, num_values, 0, 180 );
+        for ( int i = 0; i < num_values; i++ )
+            serialize_bits( stream, values[i], 32 );
         return true;
     }
 };
 
-struct BenchIntPacketCompileTime : public BenchIntFields
+void bench_message_packer()
 {
-    template <typename Stream> bool Serialize( Stream & stream )
+    static BenchPackerMessage messages[PackerNumMessages];
+    int channels[PackerNumMessages];
+    uint64_t rng = 1;
+    for ( int i = 0; i < PackerNumMessages; i++ )
     {
-        serialize_int_compile_time( stream, f0, -100, +100 );
-        serialize_int_compile_time( stream, f1, 0, 65535 );
-        serialize_int_compile_time( stream, f2, -1000000, +1000000 );
-        serialize_int_compile_time( stream, f3, 0, 3 );
-        serialize_int_compile_time( stream, f4, -15, +15 );
-        serialize_int_compile_time( stream, f5, 0, 1000 );
-        serialize_int_compile_time( stream, f6, -2048, +2047 );
-        serialize_int_compile_time( stream, f7, 0, 255 );
-        serialize_int_compile_time( stream, f8, -600000, +600000 );
-        serialize_int_compile_time( stream, f9, 0, 100 );
-        return true;
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        messages[i].channel = int32_t( ( rng >> 40 ) & 3 );
+        messages[i].id = i;
+        // mostly small messages, with a large one every third message or so
+        messages[i].num_values = ( ( rng >> 20 ) % 3 == 0 ) ? int32_t( 80 + ( rng >> 50 ) % 100 ) : int32_t( 2 + ( rng >> 30 ) % 30 );
+        for ( int j = 0; j < messages[i].num_values; j++ )
+            messages[i].values[j] = uint32_t( rng >> 11 ) + uint32_t( j );
+        channels[i] = messages[i].channel;
     }
-};
 
-// pair 2: mixed bit widths including one wider than 32 bits, runtime serialize_bits vs serialize_bits_compile_time
+    const int BufferSize = PackerPacketBytes + 8;       // + 8: a multiple of 8 with room for the end flag's word
+    uint8_t buffer[BufferSize];
+    memset( buffer, 0, sizeof( buffer ) );
 
-struct BenchBitsFields
-{
-    uint32_t b7, b13, b23, b3, b32, b11, b19;
-    uint64_t b48;
-};
+    static serialize::MessagePacker<PackerNumMessages> packer( PackerPacketBytes );
+    int64_t bits[PackerNumMessages];
 
-inline uint64_t bench_vary_bits_fields( BenchBitsFields & f, uint64_t rng )
-{
-    rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
-    f.b7 = uint32_t( rng ) & 127;
-    f.b13 = uint32_t( rng >> 3 ) & 8191;
-    f.b23 = uint32_t( rng >> 5 ) & 8388607;
-    f.b3 = uint32_t( rng >> 29 ) & 7;
-    f.b32 = uint32_t( rng >> 16 );
-    f.b11 = uint32_t( rng >> 37 ) & 2047;
-    f.b19 = uint32_t( rng >> 44 ) & 524287;
-    f.b48 = rng & 0xFFFFFFFFFFFFULL;
-    return rng;
+    int fifo_packets = 0;
+    int64_t fifo_bytes = 0;
+    int packer_packets[2] = { 0, 0 };
+    int64_t packer_bytes[2] = { 0, 0 };
+
+    double best_fifo = 1e30;
+    double best_packer[2] = { 1e30, 1e30 };
+
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        double start = time_now();
+        for ( int queue = 0; queue < PackerQueuesPerTrial; queue++ )
+        {
+            messages[queue % PackerNumMessages].values[0] = uint32_t( queue );
+            for ( int i = 0; i < PackerNumMessages; i++ )
+            {
+                serialize::MeasureStream measure;
+                messages[i].Serialize( measure );
+                bits[i] = 1 + measure.GetBitsProcessed();
+            }
+            fifo_packets = 0;
+            fifo_bytes = 0;
+            int i = 0;
+            while ( i < PackerNumMessages )
+            {
+                serialize::WriteStream stream( buffer, BufferSize );
+                uint32_t follows = 1;
+                while ( i < PackerNumMessages && stream.GetBitsProcessed() + bits[i] + 1 <= PackerPacketBytes * 8 )
+                {
+                    stream.SerializeBits( follows, 1 );
+                    messages[i].Serialize( stream );
+                    i++;
+                }
+                follows = 0;
+                stream.SerializeBits( follows, 1 );
+                stream.Flush();
+                bench_escape( buffer );
+                fifo_packets++;
+                fifo_bytes += stream.GetBytesProcessed();
+            }
+        }
+        double time = time_now() - start;
+        if ( time < best_fifo )
+            best_fifo = time;
+
+        for ( int ordered = 0; ordered < 2; ordered++ )
+        {
+            start = time_now();
+            for ( int queue = 0; queue < PackerQueuesPerTrial; queue++ )
+            {
+                messages[queue % PackerNumMessages].values[0] = uint32_t( queue );
+                packer_packets[ordered] = packer.Pack( messages, ordered ? channels : NULL, PackerNumMessages );
+                packer_bytes[ordered] = 0;
+                for ( int packet = 0; packet < packer_packets[ordered]; packet++ )
+                {
+                    serialize::WriteStream stream( buffer, BufferSize );
+                    if ( !packer.WritePacket( packet, messages, stream ) )
+                        exit( 1 );
+                    stream.Flush();
+                    bench_escape( buffer );
+                    packer_bytes[ordered] += stream.GetBytesProcessed();
+                }
+            }
+            time = time_now() - start;
+            if ( time < best_packer[ordered] )
+                best_packer[ordered] = time;
+        }
+    }
+
+    const double messages_per_trial = double( PackerQueuesPerTrial ) * PackerNumMessages / 1000000.0;
+
+    printf( "message packing (%d messages, %d byte packets)\n", PackerNumMessages, PackerPacketBytes );
+    printf( "    fifo:                %2d packets   %4.1f%% fill   %6.2f M messages/s\n",
+        fifo_packets, 100.0 * double( fifo_bytes ) / ( double( fifo_packets ) * PackerPacketBytes ), messages_per_trial / best_fifo );
+    printf( "    packer, 4 channels:  %2d packets   %4.1f%% fill   %6.2f M messages/s\n",
+        packer_packets[1], 100.0 * double( packer_bytes[1] ) / ( double( packer_packets[1] ) * PackerPacketBytes ), messages_per_trial / best_packer[1] );
+    printf( "    packer, unordered:   %2d packets   %4.1f%% fill   %6.2f M messages/s\n",
+        packer_packets[0], 100.0 * double( packer_bytes[0] ) / ( double( packer_packets[0] ) * PackerPacketBytes ), messages_per_trial / best_packer[0] );
 }
 
-struct BenchBitsPacketRuntime : public BenchBitsFields
+// ------------------------------------------------------------------------------------------
+
+// Replay: 1024 recorded snapshots of 32 entities each, every entity a substream, and the replay
+// reads one entity from each snapshot. "decode" reads the snapshot up to that entity. "skip" skips
+// the substreams before it. "seek" jumps to it with the field index built by one read pass over the
+// snapshot, persisted with serialize_field_index and read back once.
+
+const int ReplayNumRecords = 1024;
+const int ReplayNumFields = 32;
+const int ReplayField = 24;
+const int ReplayRecordBytes = 1024;
+const int ReplayPassesPerTrial = 64;
+
+struct BenchReplayEntity
 {
+    int32_t id;
+    int32_t health;
+    uint32_t values[12];
+
     template <typename Stream> bool Serialize( Stream & stream )
     {
-        serialize_bits( stream, b7, 7 );
-        serialize_bits( stream, b13, 13 );
-        serialize_bits( stream, b23, 23 );
-        serialize_bits( stream, b3, 3 );
-        serialize_bits( stream, b32, 32 );
-        serialize_bits( stream, b11, 11 );
-        serialize_bits( stream, b19, 19 );
-        serialize_bits( stream, b48, 48 );
+        serialize_int( stream, id, 0, 65535 );
+        serialize_int( stream, health, -100, 100 );
+        for ( int i = 0; i < 12; i++ )
+            serialize_bits( stream, values[i], 17 );
         return true;
     }
 };
 
-struct BenchBitsPacketCompileTime : public BenchBitsFields
+struct BenchReplayRecord
 {
+    BenchReplayEntity entities[ReplayNumFields];
+
     template <typename Stream> bool Serialize( Stream & stream )
     {
-        serialize_bits_compile_time( stream, b7, 7 );
-        serialize_bits_compile_time( stream, b13, 13 );
-        serialize_bits_compile_time( stream, b23, 23 );
-        serialize_bits_compile_time( stream, b3, 3 );
-        serialize_bits_compile_time( stream, b32, 32 );
-        serialize_bits_compile_time( stream, b11, 11 );
-        serialize_bits_compile_time( stream, b19, 19 );
-        serialize_bits64_compile_time( stream, b48, 48 );
+        for ( int i = 0; i < ReplayNumFields; i++ )
+            serialize_substream( stream, entities[i], 1024 );
         return true;
     }
 };
 
-// pair 3: a "generated packet" shape mixing bounded ints, bits and bools, the way schema generated code looks
-
-struct BenchGenFields
+void bench_field_index()
 {
-    int32_t sequence;       // [0,65535]
-    uint32_t ack_bits;      // 32 bits
-    uint32_t entity_id;     // 12 bits
-    int32_t pos_x, pos_y, pos_z;    // [-16384,+16383]
-    uint32_t yaw;           // 9 bits
-    bool moving;
-    bool firing;
-    uint64_t timestamp;     // 48 bits
-    int32_t weapon;         // [0,15]
-};
-
+    const int RecordBufferBytes = ReplayRecordBytes + 8;        // + 8: read allocations extend 8 bytes past the data
+    const int IndexBufferBytes = 128;
+    uint8_t * records = (uint8_t*) malloc( size_t( ReplayNumRecords ) * RecordBufferBytes );
+    uint8_t * indices = (uint8_t*) malloc( size_t( ReplayNumRecords ) * ( IndexBufferBytes + 8 ) );
+    int64_t * record_bytes = new int64_t[ReplayNumRecords];
+    memset( records, 0, size_t( ReplayNumRecords ) * RecordBufferBytes );
+    memset( indices, 0, size_t( ReplayNumRecords ) * ( IndexBufferBytes + 8 ) );
+
+    static BenchReplayRecord record;
+    uint64_t rng = 1;
+    for ( int r = 0; r < ReplayNumRecords; r++ )
+    {
+        for ( int i = 0; i < ReplayNumFields; i++ )
+        {
+            rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+            record.entities[i].id = i;
+            record.entities[i].health = int32_t( ( rng >> 40 ) % 201 ) - 100;
+            for ( int j = 0; j < 12; j++ )
+                record.entities[i].values[j] = uint32_t( rng >> ( 10 + j ) ) & 0x1FFFF;
+        }
+        uint8_t * data = records + size_t( r ) * RecordBufferBytes;
+        serialize::WriteStream stream( data, ReplayRecordBytes );
+        if ( !record.Serialize( stream ) )
+            exit( 1 );
+        stream.Flush();
+        record_bytes[r] = stream.GetBytesProcessed();
+
+        // the index pass, and the index persisted alongside the record
+        int64_t offsets[ReplayNumFields];
+        serialize::ReadStream indexPass( data, record_bytes[r] );
+        indexPass.SetFieldIndex( offsets, ReplayNumFields );
+        if ( !record.Serialize( indexPass ) )
+            exit( 1 );
+        int count = indexPass.GetNumFieldOffsets();
+        serialize::WriteStream indexStream( indices + size_t( r ) * ( IndexBufferBytes + 8 ), IndexBufferBytes );
+        if ( !serialize::serialize_field_index_internal( indexStream, offsets, count, ReplayNumFields ) )
+            exit( 1 );
+        indexStream.Flush();
+    }
+
+    // the replay loads each record's index once, up front
+    int64_t * field_offsets = new int64_t[ReplayNumRecords];
+    for ( int r = 0; r < ReplayNumRecords; r++ )
+    {
+        int64_t offsets[ReplayNumFields];
+        int count = 0;
+        serialize::ReadStream stream( indices + size_t( r ) * ( IndexBufferBytes + 8 ), IndexBufferBytes );
+        if ( !serialize::serialize_field_index_internal( stream, offsets, count, ReplayNumFields ) || count != ReplayNumFields )
+            exit( 1 );
+        field_offsets[r] = offsets[ReplayField];
+    }
+
+    double best[3] = { 1e30, 1e30, 1e30 };
+    uint64_t sum[3] = { 0, 0, 0 };
+
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        for ( int mode = 0; mode < 3; mode++ )
+        {
+            sum[mode] = 0;
+            const double start = time_now();
+            for ( int pass = 0; pass < ReplayPassesPerTrial; pass++ )
+            {
+                for ( int r = 0; r < ReplayNumRecords; r++ )
+                {
+                    serialize::ReadStream stream( records + size_t( r ) * RecordBufferBytes, record_bytes[r] );
+                    BenchReplayEntity entity;
+                    if ( mode == 0 )
+                    {
+                        for ( int i = 0; i <= ReplayField; i++ )
+                            if ( !stream.SerializeSubstream( entity, 1024 ) )
+                                exit( 1 );
+                    }
+                    else
+                    {
+                        if ( mode == 1 )
+                        {
+                            for ( int i = 0; i < ReplayField; i++ )
+                                if ( !stream.SkipSubstream( 1024 ) )
+                                    exit( 1 );
+                        }
+                        else if ( !stream.Seek( field_offsets[r] ) )
+                        {
+                            exit( 1 );
+                        }
+                        if ( !stream.SerializeSubstream( entity, 1024 ) )
+                            exit( 1 );
+                    }
+                    bench_escape( &entity );
+                    sum[mode] += uint64_t( entity.health + entity.values[3] );
+                }
+            }
+            const double time = time_now() - start;
+            if ( time < best[mode] )
+                best[mode] = time;
+        }
+    }
+
+    if ( sum[0] != sum[1] || sum[0] != sum[2] )
+        exit( 1 );
+    g_sink += sum[0];
+
+    const double reads = double( ReplayPassesPerTrial ) * ReplayNumRecords / 1000000.0;
+
+    printf( "replay, field %d of %d from %d records\n", ReplayField, ReplayNumFields, ReplayNumRecords );
+    printf( "    decode:  %7.2f M fields/s\n", reads / best[0] );
+    printf( "    skip:    %7.2f M fields/s   (%.1fx)\n", reads / best[1], best[0] / best[1] );
+    printf( "    seek:    %7.2f M fields/s   (%.1fx)\n", reads / best[2], best[0] / best[2] );
+
+    delete [] field_offsets;
+    delete [] record_bytes;
+    free( indices );
+    free( records );
+}
+
+// ------------------------------------------------------------------------------------------
+
+// Columns: 2000 rigid bodies, the shape of example.cpp's, plus an id and an object type. "objects"
+// serializes each body in turn. "columns" serializes each field across every body, from the same
+// array of bodies, and reads back into it. "arrays" serializes the same columns from and into an
+// array per field. Reading a column back into 80KB of bodies stores to a different cache line for
+// every value, one pass over the bodies per column, so past the L1 cache that layout reads slower
+// than objects however the column is coded. An array per field doesn't.
+
+const int ColumnNumBodies = 2000;
+const int ColumnBatchesPerTrial = 256;
+const int ColumnBufferBytes = 128 * 1024;
+
+struct BenchColumnBody
+{
+    float position[3];
+    float orientation[4];
+    bool atRest;
+    int32_t id;
+    int32_t type;
+
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        for ( int i = 0; i < 3; i++ )
+            serialize_float( stream, position[i] );
+        for ( int i = 0; i < 4; i++ )
+            serialize_float( stream, orientation[i] );
+        serialize_bool( stream, atRest );
+        serialize_int( stream, id, 0, 1000000 );
+        serialize_int( stream, type, 0, 15 );
+        return true;
+    }
+};
+
+struct BenchColumnObjects
+{
+    BenchColumnBody * bodies;
+
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        for ( int i = 0; i < ColumnNumBodies; i++ )
+            serialize_object( stream, bodies[i] );
+        return true;
+    }
+};
+
+struct BenchColumnBatch
+{
+    BenchColumnBody * bodies;
+
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        for ( int i = 0; i < 3; i++ )
+            serialize_float_column( stream, SERIALIZE_COLUMN( bodies, position[i] ), ColumnNumBodies );
+        for ( int i = 0; i < 4; i++ )
+            serialize_float_column( stream, SERIALIZE_COLUMN( bodies, orientation[i] ), ColumnNumBodies );
+        serialize_bool_column( stream, SERIALIZE_COLUMN( bodies, atRest ), ColumnNumBodies );
+        serialize_int_column( stream, SERIALIZE_COLUMN( bodies, id ), ColumnNumBodies, 0, 1000000 );
+        serialize_int_column( stream, SERIALIZE_COLUMN( bodies, type ), ColumnNumBodies, 0, 15 );
+        return true;
+    }
+};
+
+struct BenchColumnArrays
+{
+    float position[3][ColumnNumBodies];
+    float orientation[4][ColumnNumBodies];
+    bool atRest[ColumnNumBodies];
+    int32_t id[ColumnNumBodies];
+    int32_t type[ColumnNumBodies];
+};
+
+struct BenchColumnArrayBatch
+{
+    BenchColumnArrays * arrays;
+
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        for ( int i = 0; i < 3; i++ )
+            serialize_float_column( stream, serialize::make_column( arrays->position[i] ), ColumnNumBodies );
+        for ( int i = 0; i < 4; i++ )
+            serialize_float_column( stream, serialize::make_column( arrays->orientation[i] ), ColumnNumBodies );
+        serialize_bool_column( stream, serialize::make_column( arrays->atRest ), ColumnNumBodies );
+        serialize_int_column( stream, serialize::make_column( arrays->id ), ColumnNumBodies, 0, 1000000 );
+        serialize_int_column( stream, serialize::make_column( arrays->type ), ColumnNumBodies, 0, 15 );
+        return true;
+    }
+};
+
+void bench_column_set( BenchColumnObjects & batch, int i, float value ) { batch.bodies[i].position[0] = value; }
+void bench_column_set( BenchColumnBatch & batch, int i, float value ) { batch.bodies[i].position[0] = value; }
+void bench_column_set( BenchColumnArrayBatch & batch, int i, float value ) { batch.arrays->position[0][i] = value; }
+
+bool bench_column_match( const BenchColumnObjects & a, const BenchColumnObjects & b, int i ) { return a.bodies[i].id == b.bodies[i].id && a.bodies[i].type == b.bodies[i].type && a.bodies[i].orientation[3] == b.bodies[i].orientation[3]; }
+bool bench_column_match( const BenchColumnBatch & a, const BenchColumnBatch & b, int i ) { return a.bodies[i].id == b.bodies[i].id && a.bodies[i].type == b.bodies[i].type && a.bodies[i].orientation[3] == b.bodies[i].orientation[3]; }
+bool bench_column_match( const BenchColumnArrayBatch & a, const BenchColumnArrayBatch & b, int i ) { return a.arrays->id[i] == b.arrays->id[i] && a.arrays->type[i] == b.arrays->type[i] && a.arrays->orientation[3][i] == b.arrays->orientation[3][i]; }
+
+template <typename Batch> void bench_column_layout( const char * label, Batch & batch, Batch & read_batch, uint8_t * buffer )
+{
+    double best_write = 1e30;
+    double best_read = 1e30;
+    int64_t bytes = 0;
+
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        double start = time_now();
+        for ( int i = 0; i < ColumnBatchesPerTrial; i++ )
+        {
+            bench_column_set( batch, i % ColumnNumBodies, float( i ) );
+            serialize::WriteStream stream( buffer, ColumnBufferBytes );
+            if ( !batch.Serialize( stream ) )
+                exit( 1 );
+            stream.Flush();
+            bench_escape( buffer );
+            bytes = stream.GetBytesProcessed();
+        }
+        double time = time_now() - start;
+        if ( time < best_write )
+            best_write = time;
+
+        start = time_now();
+        for ( int i = 0; i < ColumnBatchesPerTrial; i++ )
+        {
+            serialize::ReadStream stream( buffer, bytes );
+            if ( !read_batch.Serialize( stream ) )
+                exit( 1 );
+            bench_escape( &read_batch );
+        }
+        time = time_now() - start;
+        if ( time < best_read )
+            best_read = time;
+    }
+
+    for ( int i = 0; i < ColumnNumBodies; i++ )
+    {
+        if ( !bench_column_match( read_batch, batch, i ) )
+            exit( 1 );
+    }
+
+    const double batches = double( ColumnBatchesPerTrial ) / 1000.0;
+
+    printf( "    %s %6d bytes   write %7.2f K batches/s   read %7.2f K batches/s\n", label, int( bytes ), batches / best_write, batches / best_read );
+}
+
+void bench_columns()
+{
+    BenchColumnBody * bodies = new BenchColumnBody[ColumnNumBodies];
+    BenchColumnBody * read_bodies = new BenchColumnBody[ColumnNumBodies];
+    uint8_t * buffer = (uint8_t*) malloc( ColumnBufferBytes + 8 );         // + 8: read allocations extend 8 bytes past the data
+    memset( buffer, 0, ColumnBufferBytes + 8 );
+
+    uint64_t rng = 1;
+    for ( int i = 0; i < ColumnNumBodies; i++ )
+    {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        for ( int j = 0; j < 3; j++ )
+            bodies[i].position[j] = float( int( ( rng >> ( 20 + j * 8 ) ) & 0xFFFF ) ) * 0.01f - 300.0f;
+        bodies[i].orientation[0] = 1.0f;
+        bodies[i].orientation[1] = bodies[i].orientation[2] = bodies[i].orientation[3] = 0.0f;
+        bodies[i].atRest = ( ( rng >> 50 ) & 3 ) != 0;
+        bodies[i].id = 5000 + i * 2 + int32_t( ( rng >> 60 ) & 1 );           // spawn order, with gaps
+        bodies[i].type = i / 256;                                              // spawned in groups by type
+    }
+
+    BenchColumnArrays * arrays = new BenchColumnArrays;
+    BenchColumnArrays * read_arrays = new BenchColumnArrays;
+    for ( int i = 0; i < ColumnNumBodies; i++ )
+    {
+        for ( int j = 0; j < 3; j++ )
+            arrays->position[j][i] = bodies[i].position[j];
+        for ( int j = 0; j < 4; j++ )
+            arrays->orientation[j][i] = bodies[i].orientation[j];
+        arrays->atRest[i] = bodies[i].atRest;
+        arrays->id[i] = bodies[i].id;
+        arrays->type[i] = bodies[i].type;
+    }
+
+    BenchColumnObjects objects = { bodies };
+    BenchColumnObjects read_objects = { read_bodies };
+    BenchColumnBatch columns = { bodies };
+    BenchColumnBatch read_columns = { read_bodies };
+    BenchColumnArrayBatch column_arrays = { arrays };
+    BenchColumnArrayBatch read_column_arrays = { read_arrays };
+
+    printf( "rigid bodies (%d)\n", ColumnNumBodies );
+    bench_column_layout( "objects:", objects, read_objects, buffer );
+    bench_column_layout( "columns:", columns, read_columns, buffer );
+    bench_column_layout( "arrays: ", column_arrays, read_column_arrays, buffer );
+
+    free( buffer );
+    delete read_arrays;
+    delete arrays;
+    delete [] read_bodies;
+    delete [] bodies;
+}
+
+// ------------------------------------------------------------------------------------------
+
+// Matched pairs: the same packet serialized through the runtime macros and through the compile
+// time parameter surface. Same data, same serially dependent LCG variation pattern, same escape
+// barriers, same trial structure, so any difference is the forms themselves, not the harness.
+// Each shape derives its two packet forms from one fields struct, so a single vary function
+// drives both sides of a pair with identical values.
+
+template <typename Fields, typename Packet> void bench_packet_shape( const char * label, uint64_t (*vary)( Fields &, uint64_t ) )
+{
+    uint8_t buffer[256];
+    memset( buffer, 0, sizeof( buffer ) );
+
+    Packet packet = Packet();
+
+    // pre-write variant packets for the read benchmark, using the same LCG sequence as the write loop
+    uint8_t variant_buffers[NumVariants][256];
+    int bytes_per_packet = 0;
+    {
+        uint64_t rng = 1;
+        for ( int k = 0; k < NumVariants; k++ )
+        {
+            memset( variant_buffers[k], 0, sizeof( variant_buffers[k] ) );
+            rng = vary( packet, rng );
+            serialize::WriteStream stream( variant_buffers[k], (int) sizeof( variant_buffers[k] ) );
+            if ( !packet.Serialize( stream ) )
+                exit( 1 );
+            stream.Flush();
+            bytes_per_packet = stream.GetBytesProcessed();
+        }
+    }
+
+    double best_write = 1e30;
+    double best_read = 1e30;
+
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        uint64_t rng = 1;
+
+        double start = time_now();
+        for ( int i = 0; i < StreamNumPackets; i++ )
+        {
+            rng = vary( packet, rng );
+            serialize::WriteStream stream( buffer, (int) sizeof( buffer ) );
+            if ( !packet.Serialize( stream ) )
+                exit( 1 );
+            stream.Flush();
+            bench_escape( buffer );
+            g_sink = g_sink + (uint64_t) stream.GetBytesProcessed();
+        }
+        double time = time_now() - start;
+        if ( time < best_write )
+            best_write = time;
+
+        start = time_now();
+        for ( int i = 0; i < StreamNumPackets; i++ )
+        {
+            serialize::ReadStream stream( variant_buffers[i & ( NumVariants - 1 )], bytes_per_packet );
+            Packet read_packet;
+            if ( !read_packet.Serialize( stream ) )
+                exit( 1 );
+            bench_escape( &read_packet );               // every decoded field is observed, so the full decode must happen
+            g_sink = g_sink + (uint64_t) *(const uint8_t*) &read_packet;
+        }
+        time = time_now() - start;
+        if ( time < best_read )
+            best_read = time;
+    }
+
+    const double packets = double( StreamNumPackets ) / 1000000.0;
+
+    printf( "%s  write: %6.1f M packets/s   read: %6.1f M packets/s\n", label, packets / best_write, packets / best_read );
+}
+
+// pair 1: a realistic packet of ~10 bounded ints, runtime serialize_int vs serialize_int_compile_time
+
+struct BenchIntFields
+{
+    int32_t f0, f1, f2, f3, f4, f5, f6, f7, f8, f9;
+};
+
+inline uint64_t bench_vary_int_fields( BenchIntFields & f, uint64_t rng )
+{
+    rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    f.f0 = int32_t( ( rng >> 8 ) & 63 ) - 32;                       // within [-100,+100]
+    f.f1 = int32_t( uint32_t( rng >> 16 ) & 65535 );                // [0,65535]
+    f.f2 = int32_t( ( rng >> 24 ) & 0xFFFFF ) - 500000;             // within [-1000000,+1000000]
+    f.f3 = int32_t( uint32_t( rng >> 2 ) & 3 );                     // [0,3]
+    f.f4 = int32_t( ( rng >> 11 ) & 15 ) - 8;                       // within [-15,+15]
+    f.f5 = int32_t( uint32_t( rng >> 22 ) & 511 );                  // within [0,1000]
+    f.f6 = int32_t( ( rng >> 33 ) & 2047 ) - 1024;                  // within [-2048,+2047]
+    f.f7 = int32_t( uint32_t( rng >> 40 ) & 255 );                  // [0,255]
+    f.f8 = int32_t( ( rng >> 30 ) & 0xFFFFF ) - 500000;             // within [-600000,+600000]
+    f.f9 = int32_t( uint32_t( rng >> 57 ) & 63 );                   // within [0,100]
+    return rng;
+}
+
+struct BenchIntPacketRuntime : public BenchIntFields
+{
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        serialize_int( stream, f0, -100, +100 );
+        serialize_int( stream, f1, 0, 65535 );
+        serialize_int( stream, f2, -1000000, +1000000 );
+        serialize_int( stream, f3, 0, 3 );
+        serialize_int( stream, f4, -15, +15 );
+        serialize_int( stream, f5, 0, 1000 );
+        serialize_int( stream, f6, -2048, +2047 );
+        serialize_int( stream, f7, 0, 255 );
+        serialize_int( stream, f8, -600000, +600000 );
+        serialize_int( stream, f9, 0, 100 );
+        return true;
+    }
+};
+
+struct BenchIntPacketCompileTime : public BenchIntFields
+{
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        serialize_int_compile_time( stream, f0, -100, +100 );
+        serialize_int_compile_time( stream, f1, 0, 65535 );
+        serialize_int_compile_time( stream, f2, -1000000, +1000000 );
+        serialize_int_compile_time( stream, f3, 0, 3 );
+        serialize_int_compile_time( stream, f4, -15, +15 );
+        serialize_int_compile_time( stream, f5, 0, 1000 );
+        serialize_int_compile_time( stream, f6, -2048, +2047 );
+        serialize_int_compile_time( stream, f7, 0, 255 );
+        serialize_int_compile_time( stream, f8, -600000, +600000 );
+        serialize_int_compile_time( stream, f9, 0, 100 );
+        return true;
+    }
+};
+
+// pair 2: mixed bit widths including one wider than 32 bits, runtime serialize_bits vs serialize_bits_compile_time
+
+struct BenchBitsFields
+{
+    uint32_t b7, b13, b23, b3, b32, b11, b19;
+    uint64_t b48;
+};
+
+inline uint64_t bench_vary_bits_fields( BenchBitsFields & f, uint64_t rng )
+{
+    rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    f.b7 = uint32_t( rng ) & 127;
+    f.b13 = uint32_t( rng >> 3 ) & 8191;
+    f.b23 = uint32_t( rng >> 5 ) & 8388607;
+    f.b3 = uint32_t( rng >> 29 ) & 7;
+    f.b32 = uint32_t( rng >> 16 );
+    f.b11 = uint32_t( rng >> 37 ) & 2047;
+    f.b19 = uint32_t( rng >> 44 ) & 524287;
+    f.b48 = rng & 0xFFFFFFFFFFFFULL;
+    return rng;
+}
+
+struct BenchBitsPacketRuntime : public BenchBitsFields
+{
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        serialize_bits( stream, b7, 7 );
+        serialize_bits( stream, b13, 13 );
+        serialize_bits( stream, b23, 23 );
+        serialize_bits( stream, b3, 3 );
+        serialize_bits( stream, b32, 32 );
+        serialize_bits( stream, b11, 11 );
+        serialize_bits( stream, b19, 19 );
+        serialize_bits( stream, b48, 48 );
+        return true;
+    }
+};
+
+struct BenchBitsPacketCompileTime : public BenchBitsFields
+{
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        serialize_bits_compile_time( stream, b7, 7 );
+        serialize_bits_compile_time( stream, b13, 13 );
+        serialize_bits_compile_time( stream, b23, 23 );
+        serialize_bits_compile_time( stream, b3, 3 );
+        serialize_bits_compile_time( stream, b32, 32 );
+        serialize_bits_compile_time( stream, b11, 11 );
+        serialize_bits_compile_time( stream, b19, 19 );
+        serialize_bits64_compile_time( stream, b48, 48 );
+        return true;
+    }
+};
+
+// pair 3: a "generated packet" shape mixing bounded ints, bits and bools, the way schema generated code looks
+
+struct BenchGenFields
+{
+    int32_t sequence;       // [0,65535]
+    uint32_t ack_bits;      // 32 bits
+    uint32_t entity_id;     // 12 bits
+    int32_t pos_x, pos_y, pos_z;    // [-16384,+16383]
+    uint32_t yaw;           // 9 bits
+    bool moving;
+    bool firing;
+    uint64_t timestamp;     // 48 bits
+    int32_t weapon;         // [0,15]
+};
+
 inline uint64_t bench_vary_gen_fields( BenchGenFields & f, uint64_t rng )
 {
-    rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
-    f.sequence = int32_t( uint32_t( rng >> 8 ) & 65535 );
-    f.ack_bits = uint32_t( rng >> 16 );
-    f.entity_id = uint32_t( rng ) & 4095;
-    f.pos_x = int32_t( ( rng >> 20 ) & 32767 ) - 16384;
-    f.pos_y = int32_t( ( rng >> 25 ) & 32767 ) - 16384;
-    f.pos_z = int32_t( ( rng >> 30 ) & 32767 ) - 16384;
-    f.yaw = uint32_t( rng >> 3 ) & 511;
-    f.moving = ( rng & 1 ) != 0;
-    f.firing = ( rng & 2 ) != 0;
-    f.timestamp = rng & 0xFFFFFFFFFFFFULL;
-    f.weapon = int32_t( uint32_t( rng >> 60 ) & 15 );
-    return rng;
+    rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    f.sequence = int32_t( uint32_t( rng >> 8 ) & 65535 );
+    f.ack_bits = uint32_t( rng >> 16 );
+    f.entity_id = uint32_t( rng ) & 4095;
+    f.pos_x = int32_t( ( rng >> 20 ) & 32767 ) - 16384;
+    f.pos_y = int32_t( ( rng >> 25 ) & 32767 ) - 16384;
+    f.pos_z = int32_t( ( rng >> 30 ) & 32767 ) - 16384;
+    f.yaw = uint32_t( rng >> 3 ) & 511;
+    f.moving = ( rng & 1 ) != 0;
+    f.firing = ( rng & 2 ) != 0;
+    f.timestamp = rng & 0xFFFFFFFFFFFFULL;
+    f.weapon = int32_t( uint32_t( rng >> 60 ) & 15 );
+    return rng;
+}
+
+struct BenchGenPacketRuntime : public BenchGenFields
+{
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        serialize_int( stream, sequence, 0, 65535 );
+        serialize_bits( stream, ack_bits, 32 );
+        serialize_bits( stream, entity_id, 12 );
+        serialize_int( stream, pos_x, -16384, +16383 );
+        serialize_int( stream, pos_y, -16384, +16383 );
+        serialize_int( stream, pos_z, -16384, +16383 );
+        serialize_bits( stream, yaw, 9 );
+        serialize_bool( stream, moving );
+        serialize_bool( stream, firing );
+        serialize_bits( stream, timestamp, 48 );
+        serialize_int( stream, weapon, 0, 15 );
+        return true;
+    }
+};
+
+struct BenchGenPacketCompileTime : public BenchGenFields
+{
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        serialize_int_compile_time( stream, sequence, 0, 65535 );
+        serialize_bits_compile_time( stream, ack_bits, 32 );
+        serialize_bits_compile_time( stream, entity_id, 12 );
+        serialize_int_compile_time( stream, pos_x, -16384, +16383 );
+        serialize_int_compile_time( stream, pos_y, -16384, +16383 );
+        serialize_int_compile_time( stream, pos_z, -16384, +16383 );
+        serialize_bits_compile_time( stream, yaw, 9 );
+        serialize_bool_compile_time( stream, moving );
+        serialize_bool_compile_time( stream, firing );
+        serialize_bits64_compile_time( stream, timestamp, 48 );
+        serialize_int_compile_time( stream, weapon, 0, 15 );
+        return true;
+    }
+};
+
+void bench_compile_time_pairs()
+{
+    bench_packet_shape<BenchIntFields, BenchIntPacketRuntime>          ( "int packet   (runtime):     ", bench_vary_int_fields );
+    bench_packet_shape<BenchIntFields, BenchIntPacketCompileTime>      ( "int packet   (compile time):", bench_vary_int_fields );
+    bench_packet_shape<BenchBitsFields, BenchBitsPacketRuntime>        ( "bits packet  (runtime):     ", bench_vary_bits_fields );
+    bench_packet_shape<BenchBitsFields, BenchBitsPacketCompileTime>    ( "bits packet  (compile time):", bench_vary_bits_fields );
+    bench_packet_shape<BenchGenFields, BenchGenPacketRuntime>          ( "mixed packet (runtime):     ", bench_vary_gen_fields );
+    bench_packet_shape<BenchGenFields, BenchGenPacketCompileTime>      ( "mixed packet (compile time):", bench_vary_gen_fields );
+}
+
+// ------------------------------------------------------------------------------------------
+
+#if defined( SERIALIZE_HAS_THREADS )
+
+// BatchWriter: a tick's worth of per-client snapshots, each 64 packets of entity state, written
+// on 1 thread and up to every core. Half the jobs bring buffers, half write into the arenas.
+
+struct BenchClientSnapshot
+{
+    BenchPacket entities[64];
+
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        for ( int i = 0; i < 64; i++ )
+        {
+            if ( !entities[i].Serialize( stream ) )
+                return false;
+        }
+        return true;
+    }
+};
+
+const int BatchNumClients = 1024;
+const int BatchSnapshotBytes = 4096;
+const int BatchMaxThreads = 64;
+
+void bench_batch_writer_threads( int num_threads, BenchClientSnapshot * snapshots, uint8_t * buffers, uint8_t * arena, int64_t arena_bytes )
+{
+    serialize::BatchWriter<BatchMaxThreads> writer( num_threads, arena, arena_bytes );
+    serialize::BatchWriteJob<BenchClientSnapshot> * jobs = new serialize::BatchWriteJob<BenchClientSnapshot>[BatchNumClients];
+
+    double best = 1e30;
+    int64_t bytes = 0;
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        double start = time_now();
+        for ( int pass = 0; pass < 10; pass++ )
+        {
+            for ( int i = 0; i < BatchNumClients; i++ )
+            {
+                jobs[i].object = &snapshots[i];
+                jobs[i].buffer = ( i & 1 ) ? buffers + size_t( i ) * BatchSnapshotBytes : NULL;
+                jobs[i].buffer_bytes = BatchSnapshotBytes;
+            }
+            if ( !writer.Write( jobs, BatchNumClients ) )
+                exit( 1 );
+            bench_escape( buffers );
+            bench_escape( arena );
+        }
+        double time = time_now() - start;
+        if ( time < best )
+            best = time;
+        bytes = 0;
+        for ( int i = 0; i < BatchNumClients; i++ )
+            bytes += jobs[i].bytes;
+    }
+
+    const double snapshots_per_second = 10.0 * BatchNumClients / best;
+    const double mb_per_second = 10.0 * double( bytes ) / best / ( 1024.0 * 1024.0 );
+
+    printf( "batch writer %2d thread%s  %8.0f snapshots/s  %8.1f MB/s\n", num_threads, num_threads == 1 ? ": " : "s:", snapshots_per_second, mb_per_second );
+
+    delete [] jobs;
+}
+
+void bench_batch_writer()
+{
+    BenchClientSnapshot * snapshots = new BenchClientSnapshot[BatchNumClients];
+    uint64_t rng = 1;
+    for ( int i = 0; i < BatchNumClients; i++ )
+    {
+        for ( int j = 0; j < 64; j++ )
+        {
+            snapshots[i].entities[j].Init();
+            rng = bench_vary_packet( snapshots[i].entities[j], rng );
+        }
+    }
+
+    int num_cores = int( std::thread::hardware_concurrency() );
+    if ( num_cores < 1 )
+        num_cores = 1;
+    if ( num_cores > BatchMaxThreads )
+        num_cores = BatchMaxThreads;
+
+    // any thread may steal every arena job, so each slice holds all of them
+    const int64_t arena_bytes = int64_t( num_cores ) * BatchNumClients * BatchSnapshotBytes;
+    uint8_t * buffers = (uint8_t*) calloc( BatchNumClients, BatchSnapshotBytes );
+    uint8_t * arena = (uint8_t*) calloc( size_t( arena_bytes ), 1 );
+
+    for ( int num_threads = 1; num_threads < num_cores; num_threads *= 2 )
+        bench_batch_writer_threads( num_threads, snapshots, buffers, arena, arena_bytes );
+    bench_batch_writer_threads( num_cores, snapshots, buffers, arena, arena_bytes );
+
+    free( arena );
+    free( buffers );
+    delete [] snapshots;
+}
+
+// ------------------------------------------------------------------------------------------
+
+// BatchReader: batches of 64 packets, the most one recvmmsg call returns here, each a small header
+// naming one of 256 connections and an entity state body, read on 1 thread and up to every core.
+// First from memory, then on Linux through a real UDP socket on loopback with sendmmsg/recvmmsg.
+
+struct BenchBatchHeader
+{
+    uint32_t connection;
+    uint32_t sequence;
+
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        serialize_bits( stream, connection, 16 );
+        serialize_bits( stream, sequence, 16 );
+        return true;
+    }
+};
+
+inline uint64_t bench_batch_connection( const BenchBatchHeader & header )
+{
+    return header.connection;
+}
+
+const int BatchReadPackets = 64;
+const int BatchReadNumBatches = 256;
+const int BatchReadPacketBytes = 128;
+
+struct BenchBatchReadState
+{
+    uint8_t packets[BatchReadNumBatches][BatchReadPackets][BatchReadPacketBytes + 8];     // + 8: read allocations extend 8 bytes past the data
+    int packet_bytes[BatchReadNumBatches][BatchReadPackets];
+    BenchBatchHeader headers[BatchReadPackets];
+    BenchPacket bodies[BatchReadPackets];
+    serialize::BatchReadJob<BenchBatchHeader, BenchPacket> jobs[BatchReadPackets];
+};
+
+void bench_batch_reader_threads( int num_threads, BenchBatchReadState & state )
+{
+    serialize::BatchReader<BatchMaxThreads, BatchReadPackets> reader( num_threads );
+
+    double best = 1e30;
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        double start = time_now();
+        for ( int pass = 0; pass < 10; pass++ )
+        {
+            for ( int batch = 0; batch < BatchReadNumBatches; batch++ )
+            {
+                for ( int i = 0; i < BatchReadPackets; i++ )
+                {
+                    state.jobs[i].packet = state.packets[batch][i];
+                    state.jobs[i].packet_bytes = state.packet_bytes[batch][i];
+                    state.jobs[i].header = &state.headers[i];
+                    state.jobs[i].body = &state.bodies[i];
+                }
+                if ( !reader.Read( state.jobs, BatchReadPackets, bench_batch_connection ) )
+                    exit( 1 );
+                bench_escape( state.bodies );
+            }
+        }
+        double time = time_now() - start;
+        if ( time < best )
+            best = time;
+    }
+
+    const double packets = 10.0 * BatchReadNumBatches * BatchReadPackets / 1000000.0;
+    printf( "batch reader %2d thread%s  %6.2f M packets/s\n", num_threads, num_threads == 1 ? ": " : "s:", packets / best );
+}
+
+#if defined( __linux__ )
+
+// the loopback harness: every batch goes out through sendmmsg and comes back through recvmmsg before it is read
+
+void bench_batch_reader_loopback( int num_threads, BenchBatchReadState & state )
+{
+    const int fd = socket( AF_INET, SOCK_DGRAM, 0 );
+    if ( fd < 0 )
+    {
+        printf( "batch reader loopback: no socket, skipped\n" );
+        return;
+    }
+    sockaddr_in address;
+    memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    address.sin_port = 0;
+    socklen_t address_length = sizeof( address );
+    int receive_buffer = 4 * 1024 * 1024;
+    setsockopt( fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof( receive_buffer ) );
+    if ( bind( fd, (sockaddr*) &address, sizeof( address ) ) != 0 || getsockname( fd, (sockaddr*) &address, &address_length ) != 0 )
+    {
+        printf( "batch reader loopback: can't bind, skipped\n" );
+        close( fd );
+        return;
+    }
+
+    static uint8_t received[BatchReadPackets][BatchReadPacketBytes + 8];
+    mmsghdr send_messages[BatchReadPackets];
+    mmsghdr receive_messages[BatchReadPackets];
+    iovec send_vectors[BatchReadPackets];
+    iovec receive_vectors[BatchReadPackets];
+    memset( send_messages, 0, sizeof( send_messages ) );
+    memset( receive_messages, 0, sizeof( receive_messages ) );
+    for ( int i = 0; i < BatchReadPackets; i++ )
+    {
+        send_messages[i].msg_hdr.msg_name = &address;
+        send_messages[i].msg_hdr.msg_namelen = sizeof( address );
+        send_messages[i].msg_hdr.msg_iov = &send_vectors[i];
+        send_messages[i].msg_hdr.msg_iovlen = 1;
+        receive_vectors[i].iov_base = received[i];
+        receive_vectors[i].iov_len = BatchReadPacketBytes;
+        receive_messages[i].msg_hdr.msg_iov = &receive_vectors[i];
+        receive_messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    serialize::BatchReader<BatchMaxThreads, BatchReadPackets> reader( num_threads );
+
+    double best = 1e30;
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        double start = time_now();
+        for ( int batch = 0; batch < BatchReadNumBatches; batch++ )
+        {
+            for ( int i = 0; i < BatchReadPackets; i++ )
+            {
+                send_vectors[i].iov_base = state.packets[batch][i];
+                send_vectors[i].iov_len = size_t( state.packet_bytes[batch][i] );
+            }
+            if ( sendmmsg( fd, send_messages, BatchReadPackets, 0 ) != BatchReadPackets )
+                exit( 1 );
+            int num_received = 0;
+            while ( num_received < BatchReadPackets )
+            {
+                const int result = recvmmsg( fd, receive_messages + num_received, BatchReadPackets - num_received, 0, NULL );
+                if ( result <= 0 )
+                    exit( 1 );
+                num_received += result;
+            }
+            for ( int i = 0; i < BatchReadPackets; i++ )
+            {
+                state.jobs[i].packet = received[i];
+                state.jobs[i].packet_bytes = int( receive_messages[i].msg_len );
+                state.jobs[i].header = &state.headers[i];
+                state.jobs[i].body = &state.bodies[i];
+            }
+            if ( !reader.Read( state.jobs, BatchReadPackets, bench_batch_connection ) )
+                exit( 1 );
+            bench_escape( state.bodies );
+        }
+        double time = time_now() - start;
+        if ( time < best )
+            best = time;
+    }
+
+    close( fd );
+
+    const double packets = double( BatchReadNumBatches ) * BatchReadPackets / 1000000.0;
+    printf( "batch reader %2d thread%s  %6.2f M packets/s (loopback)\n", num_threads, num_threads == 1 ? ": " : "s:", packets / best );
+}
+
+#endif // #if defined( __linux__ )
+
+void bench_batch_reader()
+{
+    BenchBatchReadState * state = new BenchBatchReadState;
+    memset( state->packets, 0, sizeof( state->packets ) );
+
+    uint64_t rng = 1;
+    uint32_t sequence[256] = { 0 };
+    for ( int batch = 0; batch < BatchReadNumBatches; batch++ )
+    {
+        for ( int i = 0; i < BatchReadPackets; i++ )
+        {
+            BenchBatchHeader header;
+            BenchPacket body;
+            body.Init();
+            rng = bench_vary_packet( body, rng );
+            header.connection = uint32_t( rng >> 56 );
+            header.sequence = ++sequence[header.connection] & 0xFFFF;
+            serialize::WriteStream stream( state->packets[batch][i], BatchReadPacketBytes );
+            if ( !header.Serialize( stream ) || !body.Serialize( stream ) )
+                exit( 1 );
+            stream.Flush();
+            state->packet_bytes[batch][i] = int( stream.GetBytesProcessed() );
+        }
+    }
+
+    int num_cores = int( std::thread::hardware_concurrency() );
+    if ( num_cores < 1 )
+        num_cores = 1;
+    if ( num_cores > BatchMaxThreads )
+        num_cores = BatchMaxThreads;
+
+    for ( int num_threads = 1; num_threads < num_cores; num_threads *= 2 )
+        bench_batch_reader_threads( num_threads, *state );
+    bench_batch_reader_threads( num_cores, *state );
+
+#if defined( __linux__ )
+    for ( int num_threads = 1; num_threads < num_cores; num_threads *= 2 )
+        bench_batch_reader_loopback( num_threads, *state );
+    bench_batch_reader_loopback( num_cores, *state );
+#endif // #if defined( __linux__ )
+
+    delete state;
+}
+
+#endif // #if defined( SERIALIZE_HAS_THREADS )
+
+// ------------------------------------------------------------------------------------------
+
+// PacketRing: a simulation thread writes packets and a network thread takes them, through the
+// ring, against the same hand over through a mutex guarded queue that copies each packet in and out.
+
+typedef serialize::PacketRing<256, 128> BenchRing;
+
+const int RingNumPackets = 1000000;
+
+struct BenchLockedQueue
+{
+    std::mutex mutex;
+    uint8_t data[256][128 + 8];
+    int bytes[256];
+    int head;
+    int tail;
+};
+
+void bench_ring_producer( BenchRing * ring )
+{
+    BenchPacket packet;
+    packet.Init();
+    uint64_t rng = 1;
+    for ( int i = 0; i < RingNumPackets; i++ )
+    {
+        rng = bench_vary_packet( packet, rng );
+        uint8_t * buffer = NULL;
+        while ( ( buffer = ring->BeginWrite() ) == NULL )
+            std::this_thread::yield();
+        serialize::WriteStream stream( buffer, ring->GetSlotBytes() );
+        if ( !packet.Serialize( stream ) )
+            exit( 1 );
+        stream.Flush();
+        ring->CommitWrite( int( stream.GetBytesProcessed() ) );
+    }
+}
+
+void bench_locked_producer( BenchLockedQueue * queue )
+{
+    BenchPacket packet;
+    packet.Init();
+    uint64_t rng = 1;
+    uint8_t buffer[128 + 8];
+    for ( int i = 0; i < RingNumPackets; i++ )
+    {
+        rng = bench_vary_packet( packet, rng );
+        serialize::WriteStream stream( buffer, 128 );
+        if ( !packet.Serialize( stream ) )
+            exit( 1 );
+        stream.Flush();
+        const int bytes = int( stream.GetBytesProcessed() );
+        while ( true )
+        {
+            std::unique_lock<std::mutex> lock( queue->mutex );
+            if ( queue->head - queue->tail < 256 )
+            {
+                memcpy( queue->data[ queue->head & 255 ], buffer, bytes );
+                queue->bytes[ queue->head & 255 ] = bytes;
+                queue->head++;
+                break;
+            }
+            lock.unlock();
+            std::this_thread::yield();
+        }
+    }
+}
+
+void bench_packet_ring()
+{
+    BenchRing * ring = new BenchRing;
+    BenchLockedQueue * queue = new BenchLockedQueue;
+
+    double best_ring = 1e30;
+    double best_locked = 1e30;
+
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        ring->Reset();
+        double start = time_now();
+        {
+            std::thread producer( bench_ring_producer, ring );
+            BenchPacket read_packet;
+            for ( int i = 0; i < RingNumPackets; i++ )
+            {
+                int bytes = 0;
+                const uint8_t * data = NULL;
+                while ( ( data = ring->BeginRead( bytes ) ) == NULL )
+                    std::this_thread::yield();
+                serialize::ReadStream stream( data, bytes );
+                if ( !read_packet.Serialize( stream ) )
+                    exit( 1 );
+                ring->EndRead();
+                bench_escape( &read_packet );
+            }
+            producer.join();
+        }
+        double time = time_now() - start;
+        if ( time < best_ring )
+            best_ring = time;
+
+        queue->head = 0;
+        queue->tail = 0;
+        start = time_now();
+        {
+            std::thread producer( bench_locked_producer, queue );
+            BenchPacket read_packet;
+            uint8_t buffer[128 + 8];
+            for ( int i = 0; i < RingNumPackets; i++ )
+            {
+                int bytes = 0;
+                while ( true )
+                {
+                    std::unique_lock<std::mutex> lock( queue->mutex );
+                    if ( queue->head != queue->tail )
+                    {
+                        bytes = queue->bytes[ queue->tail & 255 ];
+                        memcpy( buffer, queue->data[ queue->tail & 255 ], bytes );
+                        queue->tail++;
+                        break;
+                    }
+                    lock.unlock();
+                    std::this_thread::yield();
+                }
+                serialize::ReadStream stream( buffer, bytes );
+                if ( !read_packet.Serialize( stream ) )
+                    exit( 1 );
+                bench_escape( &read_packet );
+            }
+            producer.join();
+        }
+        time = time_now() - start;
+        if ( time < best_locked )
+            best_locked = time;
+    }
+
+    const double packets = double( RingNumPackets ) / 1000000.0;
+    printf( "packet ring:   %6.1f M packets/s\n", packets / best_ring );
+    printf( "locked queue:  %6.1f M packets/s\n", packets / best_locked );
+
+    delete queue;
+    delete ring;
+}
+
+// ------------------------------------------------------------------------------------------
+
+// Checksums: a log of 100000 packets written into one buffer with a checksum at the end, computed
+// by a second pass over the buffer after writing it, against the CRC folded in as each word is
+// stored. And a checksum on every packet, read back from the packet's bytes against folded in.
+// Reads verify the checksum in one pass over the bytes read.
+
+const int ChecksumNumPackets = 100000;
+const int64_t ChecksumLogBytes = int64_t( ChecksumNumPackets ) * 128;
+
+double bench_checksum_log( uint8_t * buffer, int mode, int64_t & bytes )
+{
+    double best = 1e30;
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        BenchPacket packet;
+        packet.Init();
+        uint64_t rng = 1;
+        const double start = time_now();
+        serialize::WriteStream stream( buffer, ChecksumLogBytes );
+        if ( mode == 2 )
+            stream.EnableChecksum();
+        for ( int i = 0; i < ChecksumNumPackets; i++ )
+        {
+            rng = bench_vary_packet( packet, rng );
+            if ( !packet.Serialize( stream ) )
+                exit( 1 );
+        }
+        if ( mode != 0 )
+            stream.SerializeChecksum();
+        stream.Flush();
+        const double time = time_now() - start;
+        bench_escape( buffer );
+        bytes = stream.GetBytesProcessed();
+        if ( time < best )
+            best = time;
+    }
+    return best;
+}
+
+struct BenchChecksumPacket
+{
+    BenchPacket packet;
+
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        if ( !packet.Serialize( stream ) )
+            return false;
+        serialize_checksum( stream );
+        return true;
+    }
+};
+
+void bench_checksum()
+{
+    uint8_t * buffer = (uint8_t*) malloc( ChecksumLogBytes + 8 );       // + 8: read allocations extend 8 bytes past the data
+    memset( buffer, 0, ChecksumLogBytes + 8 );
+
+    int64_t bytes = 0;
+    const double plain_time = bench_checksum_log( buffer, 0, bytes );
+    const double after_time = bench_checksum_log( buffer, 1, bytes );
+    const double fused_time = bench_checksum_log( buffer, 2, bytes );
+
+    double best_verify = 1e30;
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        const double start = time_now();
+        serialize::ReadStream stream( buffer, bytes );
+        BenchPacket packet;
+        for ( int i = 0; i < ChecksumNumPackets; i++ )
+        {
+            if ( !packet.Serialize( stream ) )
+                exit( 1 );
+        }
+        if ( !stream.SerializeChecksum() )
+            exit( 1 );
+        const double time = time_now() - start;
+        g_sink = g_sink + (uint64_t) packet.b;
+        if ( time < best_verify )
+            best_verify = time;
+    }
+
+    // a checksum per packet
+    uint8_t packet_buffer[256 + 8];
+    memset( packet_buffer, 0, sizeof( packet_buffer ) );
+    double best_packet[2] = { 1e30, 1e30 };
+    int64_t packet_bytes = 0;
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        for ( int fused = 0; fused <= 1; fused++ )
+        {
+            BenchChecksumPacket packet;
+            packet.packet.Init();
+            uint64_t rng = 1;
+            const double start = time_now();
+            for ( int i = 0; i < StreamNumPackets; i++ )
+            {
+                rng = bench_vary_packet( packet.packet, rng );
+                serialize::WriteStream stream( packet_buffer, 256 );
+                if ( fused )
+                    stream.EnableChecksum();
+                if ( !packet.Serialize( stream ) )
+                    exit( 1 );
+                stream.Flush();
+                bench_escape( packet_buffer );
+                packet_bytes = stream.GetBytesProcessed();
+            }
+            const double time = time_now() - start;
+            if ( time < best_packet[fused] )
+                best_packet[fused] = time;
+        }
+    }
+
+    double best_packet_read = 1e30;
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        const double start = time_now();
+        for ( int i = 0; i < StreamNumPackets; i++ )
+        {
+            serialize::ReadStream stream( packet_buffer, packet_bytes );
+            BenchChecksumPacket packet;
+            if ( !packet.Serialize( stream ) )
+                exit( 1 );
+            bench_escape( &packet );
+            g_sink = g_sink + (uint64_t) packet.packet.b;
+        }
+        const double time = time_now() - start;
+        if ( time < best_packet_read )
+            best_packet_read = time;
+    }
+
+    const double megabytes = double( bytes ) / ( 1024.0 * 1024.0 );
+    const double packets = double( StreamNumPackets ) / 1000000.0;
+    printf( "log, no checksum:          %7.1f MB/s  (%.1f MB log)\n", megabytes / plain_time, megabytes );
+    printf( "log, checksum after:       %7.1f MB/s\n", megabytes / after_time );
+    printf( "log, checksum fused:       %7.1f MB/s\n", megabytes / fused_time );
+    printf( "log, read and verify:      %7.1f MB/s\n", megabytes / best_verify );
+    printf( "packet checksum (after):   %7.1f M packets/s  (%d bytes)\n", packets / best_packet[0], int( packet_bytes ) );
+    printf( "packet checksum (fused):   %7.1f M packets/s\n", packets / best_packet[1] );
+    printf( "packet read and verify:    %7.1f M packets/s\n", packets / best_packet_read );
+
+    free( buffer );
 }
 
-struct BenchGenPacketRuntime : public BenchGenFields
+// ------------------------------------------------------------------------------------------
+
+// Vectors: messages with up to 256 items, averaging 16, read into an array of the largest size
+// in every message, into exactly the items each message holds allocated from the heap, and into
+// the same allocated from the stream's arena, reset per packet.
+
+const int VectorMaxItems = 256;
+const int VectorNumVariants = 64;
+const int VectorPacketBytes = 4096;
+const int VectorNumPackets = 1000000;
+
+struct BenchVectorItem
 {
+    int32_t id;
+    uint32_t flags;
+    float x;
+
     template <typename Stream> bool Serialize( Stream & stream )
     {
-        serialize_int( stream, sequence, 0, 65535 );
-        serialize_bits( stream, ack_bits, 32 );
-        serialize_bits( stream, entity_id, 12 );
-        serialize_int( stream, pos_x, -16384, +16383 );
-        serialize_int( stream, pos_y, -16384, +16383 );
-        serialize_int( stream, pos_z, -16384, +16383 );
-        serialize_bits( stream, yaw, 9 );
-        serialize_bool( stream, moving );
-        serialize_bool( stream, firing );
-        serialize_bits( stream, timestamp, 48 );
-        serialize_int( stream, weapon, 0, 15 );
+        serialize_int( stream, id, 0, 65535 );
+        serialize_bits( stream, flags, 12 );
+        serialize_compressed_float( stream, x, -1000.0f, 1000.0f, 0.01f );
         return true;
     }
 };
 
-struct BenchGenPacketCompileTime : public BenchGenFields
+struct BenchFixedMessage
 {
+    uint32_t sequence;
+    int num_items;
+    BenchVectorItem items[VectorMaxItems];
+
     template <typename Stream> bool Serialize( Stream & stream )
     {
-        serialize_int_compile_time( stream, sequence, 0, 65535 );
-        serialize_bits_compile_time( stream, ack_bits, 32 );
-        serialize_bits_compile_time( stream, entity_id, 12 );
-        serialize_int_compile_time( stream, pos_x, -16384, +16383 );
-        serialize_int_compile_time( stream, pos_y, -16384, +16383 );
-        serialize_int_compile_time( stream, pos_z, -16384, +16383 );
-        serialize_bits_compile_time( stream, yaw, 9 );
-        serialize_bool_compile_time( stream, moving );
-        serialize_bool_compile_time( stream, firing );
-        serialize_bits64_compile_time( stream, timestamp, 48 );
-        serialize_int_compile_time( stream, weapon, 0, 15 );
+        serialize_bits( stream, sequence, 16 );
+        serialize_int( stream, num_items, 0, VectorMaxItems );
+        for ( int i = 0; i < num_items; i++ )
+        {
+            if ( !items[i].Serialize( stream ) )
+                return false;
+        }
         return true;
     }
 };
 
-void bench_compile_time_pairs()
+struct BenchHeapMessage
 {
-    bench_packet_shape<BenchIntFields, BenchIntPacketRuntime>          ( "int packet   (runtime):     ", bench_vary_int_fields );
-    bench_packet_shape<BenchIntFields, BenchIntPacketCompileTime>      ( "int packet   (compile time):", bench_vary_int_fields );
-    bench_packet_shape<BenchBitsFields, BenchBitsPacketRuntime>        ( "bits packet  (runtime):     ", bench_vary_bits_fields );
-    bench_packet_shape<BenchBitsFields, BenchBitsPacketCompileTime>    ( "bits packet  (compile time):", bench_vary_bits_fields );
-    bench_packet_shape<BenchGenFields, BenchGenPacketRuntime>          ( "mixed packet (runtime):     ", bench_vary_gen_fields );
-    bench_packet_shape<BenchGenFields, BenchGenPacketCompileTime>      ( "mixed packet (compile time):", bench_vary_gen_fields );
+    uint32_t sequence;
+    int num_items;
+    BenchVectorItem * items;
+
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        serialize_bits( stream, sequence, 16 );
+        serialize_int( stream, num_items, 0, VectorMaxItems );
+        if ( Stream::IsReading )
+        {
+            items = (BenchVectorItem*) malloc( sizeof( BenchVectorItem ) * ( num_items ? num_items : 1 ) );
+            if ( !items )
+                return false;
+        }
+        for ( int i = 0; i < num_items; i++ )
+        {
+            if ( !items[i].Serialize( stream ) )
+                return false;
+        }
+        return true;
+    }
+};
+
+struct BenchArenaMessage
+{
+    uint32_t sequence;
+    int num_items;
+    BenchVectorItem * items;
+
+    template <typename Stream> bool Serialize( Stream & stream )
+    {
+        serialize_bits( stream, sequence, 16 );
+        serialize_vector( stream, items, num_items, VectorMaxItems );
+        return true;
+    }
+};
+
+void bench_vector()
+{
+    static uint8_t packets[VectorNumVariants][VectorPacketBytes + 8];  // + 8: read allocations extend 8 bytes past the data
+    int64_t packet_bytes[VectorNumVariants];
+    int64_t total_items = 0;
+    {
+        static BenchVectorItem items[VectorMaxItems];
+        uint64_t rng = 1;
+        for ( int k = 0; k < VectorNumVariants; k++ )
+        {
+            BenchArenaMessage message;
+            message.sequence = uint32_t( k );
+            rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+            message.num_items = ( ( rng >> 33 ) & 31 ) == 0 ? VectorMaxItems : int( ( rng >> 40 ) & 15 );
+            message.items = items;
+            for ( int i = 0; i < message.num_items; i++ )
+            {
+                items[i].id = i;
+                items[i].flags = uint32_t( i * 7 ) & 0xFFF;
+                items[i].x = float( i ) * 0.5f;
+            }
+            memset( packets[k], 0, sizeof( packets[k] ) );
+            serialize::WriteStream stream( packets[k], VectorPacketBytes );
+            if ( !message.Serialize( stream ) )
+                exit( 1 );
+            stream.Flush();
+            packet_bytes[k] = stream.GetBytesProcessed();
+            total_items += message.num_items;
+        }
+    }
+
+    uint8_t arena_memory[VectorMaxItems * sizeof( BenchVectorItem ) + 16];
+    serialize::Arena arena( arena_memory, sizeof( arena_memory ) );
+
+    double best[3] = { 1e30, 1e30, 1e30 };
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        double start = time_now();
+        for ( int i = 0; i < VectorNumPackets; i++ )
+        {
+            const int k = i & ( VectorNumVariants - 1 );
+            serialize::ReadStream stream( packets[k], packet_bytes[k] );
+            BenchFixedMessage message;
+            if ( !message.Serialize( stream ) )
+                exit( 1 );
+            bench_escape( &message );
+            g_sink = g_sink + (uint64_t) message.num_items;
+        }
+        double time = time_now() - start;
+        if ( time < best[0] )
+            best[0] = time;
+
+        start = time_now();
+        for ( int i = 0; i < VectorNumPackets; i++ )
+        {
+            const int k = i & ( VectorNumVariants - 1 );
+            serialize::ReadStream stream( packets[k], packet_bytes[k] );
+            BenchHeapMessage message;
+            if ( !message.Serialize( stream ) )
+                exit( 1 );
+            bench_escape( message.items );
+            g_sink = g_sink + (uint64_t) message.num_items;
+            free( message.items );
+        }
+        time = time_now() - start;
+        if ( time < best[1] )
+            best[1] = time;
+
+        start = time_now();
+        for ( int i = 0; i < VectorNumPackets; i++ )
+        {
+            const int k = i & ( VectorNumVariants - 1 );
+            arena.Reset();
+            serialize::ReadStream stream( packets[k], packet_bytes[k] );
+            stream.SetArena( &arena );
+            BenchArenaMessage message;
+            if ( !message.Serialize( stream ) )
+                exit( 1 );
+            bench_escape( message.items );
+            g_sink = g_sink + (uint64_t) message.num_items;
+        }
+        time = time_now() - start;
+        if ( time < best[2] )
+            best[2] = time;
+    }
+
+    const double packets_m = double( VectorNumPackets ) / 1000000.0;
+    const double average_bytes = double( total_items ) / VectorNumVariants * sizeof( BenchVectorItem );
+    printf( "vector, max size array:    %7.1f M packets/s  (%d bytes per message)\n", packets_m / best[0], int( sizeof( BenchFixedMessage ) ) );
+    printf( "vector, heap:              %7.1f M packets/s  (%.0f bytes of items per message on average)\n", packets_m / best[1], average_bytes );
+    printf( "vector, arena:             %7.1f M packets/s\n", packets_m / best[2] );
+}
+
+// ------------------------------------------------------------------------------------------
+
+#if defined( SERIALIZE_HAS_FILES )
+
+// FileWriteStream: a replay log of a million packets, through a 64KB double buffer to a temporary
+// file, against serializing the whole log into memory first and writing it out in one go.
+
+const int FileNumPackets = 1000000;
+const int FileBufferBytes = 64 * 1024;
+const int64_t FileMemoryBytes = int64_t( FileNumPackets ) * 128;
+
+double bench_file_stream( int fd, uint8_t * buffer, bool background, int64_t & bytes )
+{
+    double best = 1e30;
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        if ( ftruncate( fd, 0 ) != 0 || lseek( fd, 0, SEEK_SET ) != 0 )
+            exit( 1 );
+        BenchPacket packet;
+        packet.Init();
+        uint64_t rng = 1;
+        const double start = time_now();
+        {
+            serialize::FileWriteStream stream( fd, buffer, FileBufferBytes, background );
+            for ( int i = 0; i < FileNumPackets; i++ )
+            {
+                rng = bench_vary_packet( packet, rng );
+                if ( !packet.Serialize( stream ) )
+                    exit( 1 );
+            }
+            if ( !stream.Flush() )
+                exit( 1 );
+            bytes = stream.GetBytesProcessed();
+        }
+        const double time = time_now() - start;
+        if ( time < best )
+            best = time;
+    }
+    return best;
+}
+
+void bench_file_write_stream()
+{
+    FILE * file = tmpfile();
+    if ( !file )
+        exit( 1 );
+    const int fd = fileno( file );
+
+    uint8_t * buffer = (uint8_t*) malloc( FileBufferBytes );
+    uint8_t * memory = (uint8_t*) malloc( FileMemoryBytes );
+
+    int64_t bytes = 0;
+    const double inline_time = bench_file_stream( fd, buffer, false, bytes );
+    const double background_time = bench_file_stream( fd, buffer, true, bytes );
+
+    double best_memory = 1e30;
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        if ( ftruncate( fd, 0 ) != 0 || lseek( fd, 0, SEEK_SET ) != 0 )
+            exit( 1 );
+        BenchPacket packet;
+        packet.Init();
+        uint64_t rng = 1;
+        const double start = time_now();
+        serialize::WriteStream stream( memory, FileMemoryBytes );
+        for ( int i = 0; i < FileNumPackets; i++ )
+        {
+            rng = bench_vary_packet( packet, rng );
+            if ( !packet.Serialize( stream ) )
+                exit( 1 );
+        }
+        stream.Flush();
+        const uint8_t * data = stream.GetData();
+        int64_t left = stream.GetBytesProcessed();
+        while ( left > 0 )
+        {
+            const ssize_t result = write( fd, data, size_t( left ) );
+            if ( result < 0 )
+                exit( 1 );
+            data += result;
+            left -= result;
+        }
+        const double time = time_now() - start;
+        if ( time < best_memory )
+            best_memory = time;
+    }
+
+    const double megabytes = double( bytes ) / ( 1024.0 * 1024.0 );
+    printf( "file stream (in line):     %7.1f MB/s  (%.1f MB log, %d KB buffer)\n", megabytes / inline_time, megabytes, FileBufferBytes / 1024 );
+    printf( "file stream (background):  %7.1f MB/s\n", megabytes / background_time );
+    printf( "whole log in memory:       %7.1f MB/s  (%.1f MB buffer)\n", megabytes / best_memory, double( FileMemoryBytes ) / ( 1024.0 * 1024.0 ) );
+
+    free( memory );
+    free( buffer );
+    fclose( file );
+}
+
+// ReplayReader: random records out of a replay file, straight through its index, against decoding
+// every record before each one, which is all a flat concatenation of records allows.
+
+const int ReplayFileRecords = 20000;
+const int ReplayFileLookups = 1000;
+
+void bench_replay()
+{
+    char path[] = "/tmp/serialize_bench_replay_XXXXXX";
+    const int fd = mkstemp( path );
+    if ( fd < 0 )
+        exit( 1 );
+
+    serialize::ReplayRecord * records = (serialize::ReplayRecord*) malloc( sizeof( serialize::ReplayRecord ) * ReplayFileRecords );
+    uint8_t * buffer = (uint8_t*) malloc( FileBufferBytes );
+
+    {
+        serialize::ReplayWriter writer( fd, buffer, FileBufferBytes, false, records, ReplayFileRecords );
+        BenchPacket packet;
+        packet.Init();
+        uint64_t rng = 1;
+        for ( int i = 0; i < ReplayFileRecords; i++ )
+        {
+            rng = bench_vary_packet( packet, rng );
+            if ( !writer.WriteRecord( packet ) )
+                exit( 1 );
+        }
+        if ( !writer.Close() )
+            exit( 1 );
+    }
+    close( fd );
+
+    int lookups[ReplayFileLookups];
+    uint64_t rng = 12345;
+    for ( int i = 0; i < ReplayFileLookups; i++ )
+    {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        lookups[i] = int( ( rng >> 33 ) % ReplayFileRecords );
+    }
+
+    serialize::ReplayReader reader( records, ReplayFileRecords );
+    if ( !reader.Open( path ) )
+        exit( 1 );
+
+    double best_indexed = 1e30;
+    double best_scan = 1e30;
+    for ( int trial = 0; trial < NumTrials; trial++ )
+    {
+        BenchPacket packet;
+        double start = time_now();
+        for ( int i = 0; i < ReplayFileLookups; i++ )
+        {
+            if ( !reader.ReadRecord( lookups[i], packet ) )
+                exit( 1 );
+            bench_escape( &packet );
+        }
+        double time = time_now() - start;
+        if ( time < best_indexed )
+            best_indexed = time;
+
+        // the records are back to back, each starting on a byte, as a flat log would have them
+        start = time_now();
+        for ( int i = 0; i < ReplayFileLookups; i++ )
+        {
+            serialize::ReadStream stream( reader.GetData() + serialize::ReplayFormat::HeaderBytes, reader.GetBytes() - serialize::ReplayFormat::HeaderBytes );
+            for ( int j = 0; j <= lookups[i]; j++ )
+            {
+                if ( !packet.Serialize( stream ) || !stream.SerializeAlign() )
+                    exit( 1 );
+            }
+            bench_escape( &packet );
+        }
+        time = time_now() - start;
+        if ( time < best_scan )
+            best_scan = time;
+    }
+
+    printf( "replay (indexed):          %7.1f M lookups/s  (%d records, %.1f MB file)\n", ReplayFileLookups / best_indexed / 1000000.0, ReplayFileRecords, double( reader.GetBytes() ) / ( 1024.0 * 1024.0 ) );
+    printf( "replay (decode to record): %7.3f M lookups/s\n", ReplayFileLookups / best_scan / 1000000.0 );
+
+    reader.Close();
+    unlink( path );
+    free( buffer );
+    free( records );
 }
 
+#endif // #if defined( SERIALIZE_HAS_FILES )
+
 // ------------------------------------------------------------------------------------------
 
 int main()
@@ -578,6 +2351,59 @@ int main()
 
     bench_compile_time_pairs();
 
+    printf( "\n" );
+
+    bench_fan_out( 1 );
+    bench_fan_out( 64 );
+    bench_fan_out( 512 );
+
+    printf( "\n" );
+
+    bench_packet_assembler( 200 );
+    bench_packet_assembler( 2000 );
+
+    printf( "\n" );
+
+    bench_message_packer();
+
+    printf( "\n" );
+
+    bench_field_index();
+
+    printf( "\n" );
+
+    bench_columns();
+
+    printf( "\n" );
+
+#if defined( SERIALIZE_HAS_THREADS )
+    bench_batch_writer();
+
+    printf( "\n" );
+
+    bench_batch_reader();
+
+    printf( "\n" );
+#endif // #if defined( SERIALIZE_HAS_THREADS )
+
+    bench_packet_ring();
+
+    printf( "\n" );
+
+    bench_checksum();
+
+    printf( "\n" );
+
+    bench_vector();
+
+#if defined( SERIALIZE_HAS_FILES )
+    printf( "\n" );
+
+    bench_file_write_stream();
+
+    bench_replay();
+#endif // #if defined( SERIALIZE_HAS_FILES )
+
     free( buffer );
 
     printf( "\n" );
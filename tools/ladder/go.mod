@@ -0,0 +1,5 @@
+// Scoped to this tool so the C++ repository root stays free of Go module
+// files. Standard library only -- no dependencies, ever.
+module github.com/mas-bandwidth/serialize/tools/ladder
+
+go 1.21
@@ -0,0 +1,236 @@
+// Command ladder derives a serialize::RelativeLadder from a histogram of
+// sampled differences.
+//
+// serialize_int_relative spends one flag bit per tier climbed, then the
+// payload bits of the tier it lands in, and past the last tier one zero flag
+// per tier plus the raw absolute value. Which tier table is cheapest depends
+// entirely on the distribution of differences, so this reads a histogram of
+// them and searches for the table with the fewest expected bits per value.
+//
+// A tier costs bits_required( lo, hi ) payload bits, so for a given lo the only
+// tier maxima worth considering are lo + 2^b - 1: anything shorter pays the
+// same payload for fewer values. The search is exhaustive over those, memoized
+// on ( tier, lo ).
+//
+//	usage: go run ./tools/ladder [-tiers 6] [-fallback 32] [-name Name] histogram.txt
+//
+// The histogram is one sample per line, either "difference" or
+// "difference count". Blank lines and lines starting with # are ignored.
+// Differences must be at least 1: the ladder encodes strictly increasing
+// values.
+//
+// The output is a typedef to paste into code shared by both sides of the wire,
+// with the expected cost against the default ladder for comparison.
+package main
+
+import (
+	"bufio"
+	"flag"
+	"fmt"
+	"math/bits"
+	"os"
+	"sort"
+	"strconv"
+	"strings"
+)
+
+type sample struct {
+	difference uint64
+	count      uint64
+}
+
+// histogram holds the samples sorted by difference, with a running count so
+// the number of samples in [lo,hi] is two binary searches.
+type histogram struct {
+	samples    []sample
+	cumulative []uint64 // cumulative[i] = count of samples[0..i)
+	total      uint64
+}
+
+func newHistogram(samples []sample) *histogram {
+	sort.Slice(samples, func(i, j int) bool { return samples[i].difference < samples[j].difference })
+	h := &histogram{samples: samples, cumulative: make([]uint64, len(samples)+1)}
+	for i, s := range samples {
+		h.cumulative[i+1] = h.cumulative[i] + s.count
+	}
+	h.total = h.cumulative[len(samples)]
+	return h
+}
+
+// countFrom returns the number of samples with difference >= lo.
+func (h *histogram) countFrom(lo uint64) uint64 {
+	i := sort.Search(len(h.samples), func(i int) bool { return h.samples[i].difference >= lo })
+	return h.total - h.cumulative[i]
+}
+
+// countIn returns the number of samples with difference in [lo,hi].
+func (h *histogram) countIn(lo, hi uint64) uint64 {
+	above := uint64(0)
+	if hi != ^uint64(0) {
+		above = h.countFrom(hi + 1)
+	}
+	return h.countFrom(lo) - above
+}
+
+func (h *histogram) max() uint64 { return h.samples[len(h.samples)-1].difference }
+
+// bitsRequired matches serialize::bits_required64( lo, hi ).
+func bitsRequired(lo, hi uint64) int { return 64 - bits.LeadingZeros64(hi-lo) }
+
+// cost returns the total bits the ladder spends on the histogram.
+func cost(h *histogram, tiers []uint64, fallback int) uint64 {
+	total := uint64(0)
+	lo := uint64(1)
+	for i, hi := range tiers {
+		total += h.countIn(lo, hi) * uint64(i+1+bitsRequired(lo, hi))
+		lo = hi + 1
+	}
+	total += h.countFrom(lo) * uint64(len(tiers)+fallback)
+	return total
+}
+
+type key struct {
+	tier int
+	lo   uint64
+}
+
+type result struct {
+	bits  uint64
+	tiers []uint64
+}
+
+type search struct {
+	h        *histogram
+	maxTiers int
+	fallback int
+	limit    uint64 // the largest tier maximum the fallback width can carry
+	memo     map[key]result
+}
+
+// best returns the cheapest continuation for differences >= lo when tier
+// tiers have been placed before it.
+func (s *search) best(tier int, lo uint64) result {
+	remaining := s.h.countFrom(lo)
+	if remaining == 0 {
+		return result{}
+	}
+	k := key{tier, lo}
+	if r, ok := s.memo[k]; ok {
+		return r
+	}
+	// stop here: everything left takes the absolute form past tier zero flags
+	r := result{bits: remaining * uint64(tier+s.fallback)}
+	if tier < s.maxTiers {
+		for b := 0; b < 64; b++ {
+			span := uint64(1) << uint(b)
+			if span-1 > s.limit-lo {
+				break
+			}
+			hi := lo + span - 1
+			here := s.h.countIn(lo, hi) * uint64(tier+1+b)
+			if here >= r.bits {
+				break // both the samples covered and their cost grow with b, so a wider tier cannot win either
+			}
+			next := result{}
+			if hi != s.limit {
+				next = s.best(tier+1, hi+1)
+			}
+			if here+next.bits < r.bits {
+				r = result{bits: here + next.bits, tiers: append([]uint64{hi}, next.tiers...)}
+			}
+			if hi >= s.h.max() {
+				break // this tier already covers every sample: wider tiers only cost more
+			}
+		}
+	}
+	s.memo[k] = r
+	return r
+}
+
+func readHistogram(path string) ([]sample, error) {
+	f, err := os.Open(path)
+	if err != nil {
+		return nil, err
+	}
+	defer f.Close()
+	var samples []sample
+	scanner := bufio.NewScanner(f)
+	line := 0
+	for scanner.Scan() {
+		line++
+		text := strings.TrimSpace(scanner.Text())
+		if text == "" || strings.HasPrefix(text, "#") {
+			continue
+		}
+		fields := strings.Fields(text)
+		if len(fields) > 2 {
+			return nil, fmt.Errorf("%s:%d: expected \"difference\" or \"difference count\"", path, line)
+		}
+		d, err := strconv.ParseUint(fields[0], 10, 64)
+		if err != nil || d == 0 {
+			return nil, fmt.Errorf("%s:%d: difference must be an integer >= 1", path, line)
+		}
+		c := uint64(1)
+		if len(fields) == 2 {
+			if c, err = strconv.ParseUint(fields[1], 10, 64); err != nil {
+				return nil, fmt.Errorf("%s:%d: bad count", path, line)
+			}
+		}
+		samples = append(samples, sample{d, c})
+	}
+	return samples, scanner.Err()
+}
+
+func main() {
+	maxTiers := flag.Int("tiers", 6, "maximum number of tiers, in [1,8]")
+	fallback := flag.Int("fallback", 32, "raw width of the absolute form: 32 for 32 bit values, 64 for 64 bit values")
+	name := flag.String("name", "MyRelativeLadder", "name of the emitted typedef")
+	flag.Parse()
+
+	if flag.NArg() != 1 || *maxTiers < 1 || *maxTiers > 8 || *fallback < 1 || *fallback > 64 {
+		fmt.Fprintln(os.Stderr, "usage: ladder [-tiers 1..8] [-fallback 1..64] [-name Name] histogram.txt")
+		os.Exit(2)
+	}
+
+	samples, err := readHistogram(flag.Arg(0))
+	if err != nil {
+		fmt.Fprintln(os.Stderr, err)
+		os.Exit(1)
+	}
+	if len(samples) == 0 {
+		fmt.Fprintln(os.Stderr, "no samples")
+		os.Exit(1)
+	}
+
+	h := newHistogram(samples)
+	limit := ^uint64(0)
+	if *fallback < 64 {
+		limit = uint64(1)<<uint(*fallback) - 1
+	}
+	if h.max() > limit {
+		fmt.Fprintf(os.Stderr, "difference %d does not fit in a %d bit fallback\n", h.max(), *fallback)
+		os.Exit(1)
+	}
+
+	s := &search{h: h, maxTiers: *maxTiers, fallback: *fallback, limit: limit, memo: map[key]result{}}
+	r := s.best(0, 1)
+	if len(r.tiers) == 0 {
+		r.tiers = []uint64{1} // a ladder needs a tier, and a one value tier costs a single bit
+	}
+
+	args := []string{strconv.Itoa(*fallback)}
+	for _, t := range r.tiers {
+		arg := strconv.FormatUint(t, 10)
+		if t > 0xFFFFFFFF>>1 {
+			arg += "ULL"
+		}
+		args = append(args, arg)
+	}
+
+	defaultTiers := []uint64{1, 6, 23, 280, 4377, 69914}
+	fmt.Printf("// derived by tools/ladder from %d samples\n", h.total)
+	fmt.Printf("// expected %.3f bits per value (default ladder: %.3f)\n",
+		float64(cost(h, r.tiers, *fallback))/float64(h.total),
+		float64(cost(h, defaultTiers, *fallback))/float64(h.total))
+	fmt.Printf("typedef serialize::RelativeLadder<%s> %s;\n", strings.Join(args, ", "), *name)
+}